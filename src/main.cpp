@@ -1,4 +1,12 @@
 #include <qpl/qpl.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 constexpr qpl::size max_distint_colors = 30;
 
@@ -6,6 +14,8 @@ namespace info {
 	auto state_size = 4u;
 	auto neighbours_radius = 4;
 	auto hexagons_dimension = qpl::vec(300, 300);
+	qpl::size ensemble_size = 1u;
+	bool ensemble_mutate = false;
 	qpl::f64 empty_rule_chance = 0.5;
 	qpl::f64 repeated_rule_change_chance = 0.9;
 	qpl::f64 random_fill_chance = 2.0;
@@ -49,6 +59,36 @@ namespace info {
 	void calculate_neighbours_size() {
 		neighbours_size = qpl::size_cast(qpl::triangle_number(neighbours_radius) * 6 + 1);
 	}
+
+	void save_settings(qpl::save_state& state) {
+		state.save(info::state_size);
+		state.save(info::neighbours_radius);
+		state.save(info::random_fill_chance);
+		state.save(info::empty_rule_chance);
+		state.save(info::state_colors);
+	}
+	void load_settings(qpl::load_state& state) {
+		state.load(info::state_size);
+		state.load(info::neighbours_radius);
+		state.load(info::random_fill_chance);
+		state.load(info::empty_rule_chance);
+		info::calculate_neighbours_size();
+
+
+		info::state_colors.resize(info::state_size);
+		state.load(info::state_colors);
+
+		info::distinct_color_size = 0u;
+		std::unordered_set<qpl::rgb> seen;
+		for (auto& color : info::state_colors) {
+			if (seen.find(color) == seen.cend()) {
+				info::distinct_colors.push_back(color);
+				++info::distinct_color_size;
+				seen.insert(color);
+			}
+		}
+		info::distinct_color_size = qpl::min(info::distinct_color_size, max_distint_colors);
+	}
 }
 
 
@@ -120,6 +160,20 @@ struct rule {
 			this->fix_boring_states();
 		}
 	}
+	bool operator==(const rule& other) const {
+		if (this->associations.size() != other.associations.size()) {
+			return false;
+		}
+		for (qpl::size i = 0u; i < this->associations.size(); ++i) {
+			const auto& a = this->associations[i];
+			const auto& b = other.associations[i];
+			if (a.state_index != b.state_index || !std::equal(a.result_table.begin(), a.result_table.end(), b.result_table.begin(), b.result_table.end())) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	hexagon get(hexagon target, const std::vector<neighbours_uint>& neighbours) const {
 		const auto& association = this->associations[target];
 		auto value = association.result_table[neighbours[association.state_index]];
@@ -143,58 +197,180 @@ struct rule {
 		return stream.str();
 	}
 
-	void save(std::string file) const {
-		qpl::save_state state;
-		state.save(info::state_size);
-		state.save(info::neighbours_radius);
-		state.save(info::random_fill_chance);
-		state.save(info::empty_rule_chance);
-		state.save(info::state_colors);
+	void save(qpl::save_state& state) const {
 		for (auto& i : this->associations) {
 			state.save(i.state_index);
 			state.save(i.result_table);
 		}
+	}
+	void save(std::string file) const {
+		qpl::save_state state;
+		info::save_settings(state);
+		this->save(state);
 		state.file_save(file);
 	}
+	void load(qpl::load_state& state) {
+		this->associations.resize(info::state_size);
+		for (auto& i : this->associations) {
+			i.result_table.resize(info::neighbours_size);
+			state.load(i.state_index);
+			state.load(i.result_table);
+		}
+	}
 	void load(std::string file) {
 		qpl::load_state state;
 		state.file_load(file);
 
-		state.load(info::state_size);
-		state.load(info::neighbours_radius);
-		state.load(info::random_fill_chance);
-		state.load(info::empty_rule_chance);
-		info::calculate_neighbours_size();
+		info::load_settings(state);
+		this->load(state);
+	}
+};
 
 
-		info::state_colors.resize(info::state_size);
-		state.load(info::state_colors);
+struct population_statistics {
+	std::vector<qpl::size> population;
+	qpl::size changed = 0u;
+	qpl::size cells = 0u;
 
-		info::distinct_color_size = 0u;
-		std::unordered_set<qpl::rgb> seen;
-		for (auto& color : info::state_colors) {
-			if (seen.find(color) == seen.cend()) {
-				info::distinct_colors.push_back(color);
-				++info::distinct_color_size;
-				seen.insert(color);
+	void clear() {
+		this->population.assign(info::state_size, 0u);
+		this->changed = 0u;
+		this->cells = 0u;
+	}
+	void add(const population_statistics& other) {
+		this->population.resize(qpl::max(this->population.size(), other.population.size()), 0u);
+		for (qpl::size i = 0u; i < other.population.size(); ++i) {
+			this->population[i] += other.population[i];
+		}
+		this->changed += other.changed;
+		this->cells += other.cells;
+	}
+	qpl::size alive() const {
+		if (this->population.empty()) {
+			return 0u;
+		}
+		return this->cells - this->population.front();
+	}
+	qpl::f64 activity() const {
+		return this->cells ? qpl::f64_cast(this->changed) / this->cells : 0.0;
+	}
+	qpl::f64 density() const {
+		return this->cells ? qpl::f64_cast(this->alive()) / this->cells : 0.0;
+	}
+	bool collapsed() const {
+		return this->cells && (!this->changed || !this->alive());
+	}
+};
+
+//threads are kept alive between steps, starting them on every step costs about as much as stepping a small grid.
+//callers from different threads (UI and optimiser) are served one after another
+struct worker_pool {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::mutex run_mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::function<void(qpl::size)> job;
+	qpl::size job_ctr = 0u;
+	qpl::size running = 0u;
+	bool stopping = false;
+
+	worker_pool(qpl::size size) {
+		for (qpl::size i = 1u; i < size; ++i) {
+			this->threads.emplace_back([this, i] {
+				this->work(i);
+			});
+		}
+	}
+	~worker_pool() {
+		{
+			std::lock_guard lock(this->mutex);
+			this->stopping = true;
+		}
+		this->wake.notify_all();
+		for (auto& thread : this->threads) {
+			thread.join();
+		}
+	}
+
+	static worker_pool& get() {
+		static worker_pool pool(qpl::max(qpl::size_cast(std::thread::hardware_concurrency()), qpl::size{ 1u }));
+		return pool;
+	}
+	qpl::size size() const {
+		return this->threads.size() + 1;
+	}
+
+	void work(qpl::size index) {
+		qpl::size seen = 0u;
+		while (true) {
+			std::function<void(qpl::size)> job;
+			{
+				std::unique_lock lock(this->mutex);
+				this->wake.wait(lock, [&] { return this->stopping || this->job_ctr != seen; });
+				if (this->stopping) {
+					return;
+				}
+				seen = this->job_ctr;
+				job = this->job;
+			}
+			job(index);
+			{
+				std::lock_guard lock(this->mutex);
+				if (!--this->running) {
+					this->done.notify_one();
+				}
 			}
 		}
-		info::distinct_color_size = qpl::min(info::distinct_color_size, max_distint_colors);
+	}
 
-		this->associations.resize(info::state_size);
-		for (auto& i : this->associations) {
-			i.result_table.resize(info::neighbours_size);
-			state.load(i.state_index);
-			state.load(i.result_table);
+	//calls job(thread_index) once on every thread, the calling thread being index 0, and waits for all of them
+	void run(const std::function<void(qpl::size)>& job) {
+		std::lock_guard run_lock(this->run_mutex);
+		{
+			std::lock_guard lock(this->mutex);
+			this->job = job;
+			this->running = this->threads.size();
+			++this->job_ctr;
 		}
+		this->wake.notify_all();
+		job(0u);
+
+		std::unique_lock lock(this->mutex);
+		this->done.wait(lock, [&] { return !this->running; });
 	}
 };
 
-
+//ensemble members are tiled side by side in one collection rather than interleaved cell by cell.
+//each member can run its own rule, so the rule lookup is a per cell table gather that does not vectorize
+//across members. the ensemble gains from stepping all members in one parallel pass instead
 struct hexagons {
+	constexpr static qpl::size block_size = 64u;
+
+	struct block {
+		qpl::vec2s position;
+		qpl::vec2s dimension;
+		qpl::size member;
+	};
+	struct kernel_buffer {
+		std::vector<hexagon> halo;
+		std::vector<neighbours_uint> neighbours;
+		std::vector<qpl::size> offsets;
+		std::vector<qpl::size> widths;
+		std::vector<population_statistics> statistics;
+	};
+
 	std::vector<hexagon> collection;
+	std::vector<hexagon> next;
 	qpl::vec2s dimension;
+	qpl::vec2s member_dimension;
+	qpl::size ensemble_size = 1u;
 	rule rule;
+	std::vector<::rule> member_rules;
+	std::vector<block> blocks;
+	std::vector<kernel_buffer> buffers;
+	std::vector<population_statistics> member_statistics;
+	population_statistics statistics;
 
 	hexagons() {
 		this->rule.randomize();
@@ -228,17 +404,65 @@ struct hexagons {
 		return this->collection.cend();
 	}
 
-	hexagon get(qpl::isize x, qpl::isize y) const {
-		if (x < 0 || x >= qpl::signed_cast(this->dimension.x) || y < 0 || y >= qpl::signed_cast(this->dimension.y)) {
-			return hexagon{ 0 };
+	qpl::size member_size() const {
+		return this->ensemble_size * this->ensemble_size;
+	}
+	qpl::vec2s member_position(qpl::size member) const {
+		qpl::vec2s result;
+		result.x = (member % this->ensemble_size) * this->member_dimension.x;
+		result.y = (member / this->ensemble_size) * this->member_dimension.y;
+		return result;
+	}
+	const ::rule& get_rule(qpl::size member) const {
+		if (this->member_rules.empty()) {
+			return this->rule;
 		}
-		else {
-			return this->collection[y * this->dimension.x + x];
+		return this->member_rules[member];
+	}
+
+	//every member after the first runs its own mutation of the current rule. the mutations are kept until
+	//the current rule changes, so reseeding compares the same mutants on new initial conditions
+	void make_member_rules() {
+		if (!info::ensemble_mutate || this->member_size() == 1u) {
+			this->member_rules.clear();
+			return;
+		}
+		if (this->member_rules.size() == this->member_size() && this->member_rules.front() == this->rule) {
+			return;
+		}
+		this->member_rules.clear();
+		this->member_rules.resize(this->member_size(), this->rule);
+		for (qpl::size i = 1u; i < this->member_rules.size(); ++i) {
+			this->member_rules[i].mutate();
+		}
+	}
+
+	std::vector<hexagon> get_member(qpl::size member) const {
+		std::vector<hexagon> result(this->member_dimension.x * this->member_dimension.y);
+		auto position = this->member_position(member);
+		for (qpl::size y = 0u; y < this->member_dimension.y; ++y) {
+			auto source = this->collection.begin() + qpl::signed_cast((position.y + y) * this->dimension.x + position.x);
+			std::copy(source, source + qpl::signed_cast(this->member_dimension.x), result.begin() + qpl::signed_cast(y * this->member_dimension.x));
+		}
+		return result;
+	}
+	void set_member(qpl::size member, const std::vector<hexagon>& cells) {
+		auto position = this->member_position(member);
+		for (qpl::size y = 0u; y < this->member_dimension.y; ++y) {
+			auto source = cells.begin() + qpl::signed_cast(y * this->member_dimension.x);
+			std::copy(source, source + qpl::signed_cast(this->member_dimension.x), this->collection.begin() + qpl::signed_cast((position.y + y) * this->dimension.x + position.x));
 		}
 	}
 
-	std::vector<neighbours_uint> count_neighbours(qpl::isize x, qpl::isize y) const {
-		std::vector<neighbours_uint> result(info::state_size, 0);
+	//neighbours are clipped to the bounds of the ensemble member, so members never see each other
+	void count_neighbours(std::vector<neighbours_uint>& result, qpl::isize x, qpl::isize y, qpl::size member) const {
+		std::fill(result.begin(), result.end(), neighbours_uint{ 0 });
+
+		auto position = this->member_position(member);
+		auto min_x = qpl::signed_cast(position.x);
+		auto min_y = qpl::signed_cast(position.y);
+		auto max_x = min_x + qpl::signed_cast(this->member_dimension.x);
+		auto max_y = min_y + qpl::signed_cast(this->member_dimension.y);
 
 		for (qpl::isize col = 0; col < info::neighbours_radius * 2 + 1; ++col) {
 			auto width = (col + info::neighbours_radius + 1);
@@ -253,130 +477,817 @@ struct hexagons {
 				auto cx = x + i - info::neighbours_radius + (qpl::abs(dy) / 2);
 				if ((dy % 2) && (y % 2)) cx += 1;
 
-				if (cx >= 0 && cy >= 0 && cx < qpl::signed_cast(this->dimension.x) && cy < qpl::signed_cast(this->dimension.y)) {
+				if (cx >= min_x && cy >= min_y && cx < max_x && cy < max_y) {
 					if (!(cx == x && cy == y)) {
-						auto value = this->get(cx, cy);
+						auto value = this->collection[cy * this->dimension.x + cx];
 						++result[value];
 					}
 				}
 			}
 		}
+	}
+	void make_blocks() {
+		this->blocks.clear();
+		for (qpl::size member = 0u; member < this->member_size(); ++member) {
+			auto position = this->member_position(member);
+			for (qpl::size y = 0u; y < this->member_dimension.y; y += block_size) {
+				for (qpl::size x = 0u; x < this->member_dimension.x; x += block_size) {
+					block block;
+					block.position.x = position.x + x;
+					block.position.y = position.y + y;
+					block.dimension.x = qpl::min(block_size, this->member_dimension.x - x);
+					block.dimension.y = qpl::min(block_size, this->member_dimension.y - y);
+					block.member = member;
+					this->blocks.push_back(block);
+				}
+			}
+		}
+	}
+
+	//copies the block with a halo of neighbours_radius into the buffer. cells outside of the member are
+	//marked undefined - the neighbour count of undefined is never read, so no bounds checks are needed afterwards
+	void copy_halo(const block& block, kernel_buffer& buffer) const {
+		auto radius = qpl::signed_cast(info::neighbours_radius);
+		auto halo_width = block.dimension.x + qpl::size_cast(radius * 2);
+		auto halo_height = block.dimension.y + qpl::size_cast(radius * 2);
+		buffer.halo.resize(halo_width * halo_height);
+		std::fill(buffer.halo.begin(), buffer.halo.end(), undefined);
+
+		auto position = this->member_position(block.member);
+		auto min_x = qpl::signed_cast(position.x);
+		auto min_y = qpl::signed_cast(position.y);
+		auto max_x = min_x + qpl::signed_cast(this->member_dimension.x);
+		auto max_y = min_y + qpl::signed_cast(this->member_dimension.y);
+
+		auto start_x = qpl::signed_cast(block.position.x) - radius;
+		auto begin_x = qpl::max(start_x, min_x);
+		auto end_x = qpl::min(start_x + qpl::signed_cast(halo_width), max_x);
+
+		for (qpl::size hy = 0u; hy < halo_height; ++hy) {
+			auto y = qpl::signed_cast(block.position.y + hy) - radius;
+			if (y < min_y || y >= max_y) {
+				continue;
+			}
+			auto source = this->collection.begin() + (y * qpl::signed_cast(this->dimension.x));
+			auto destination = buffer.halo.begin() + qpl::signed_cast(hy * halo_width);
+			std::copy(source + begin_x, source + end_x, destination + (begin_x - start_x));
+		}
+	}
+
+	//the neighbourhood of each row is a window that slides one hexagon to the right per cell,
+	//so only the first and last hexagon of each of the 2r + 1 rows change between cells
+	void update_block(const block& block, kernel_buffer& buffer) {
+		this->copy_halo(block, buffer);
+
+		const auto& member_rule = this->get_rule(block.member);
+		auto& statistics = buffer.statistics[block.member];
+		statistics.cells += block.dimension.x * block.dimension.y;
+
+		auto radius = qpl::size_cast(info::neighbours_radius);
+		auto diameter = radius * 2 + 1;
+		auto halo_width = block.dimension.x + radius * 2;
+
+		buffer.neighbours.resize(qpl::size{ undefined } + 1);
+		buffer.offsets.resize(diameter);
+		buffer.widths.resize(diameter);
+
+		for (qpl::size ly = 0u; ly < block.dimension.y; ++ly) {
+			auto y = block.position.y + ly;
+			for (qpl::size j = 0u; j < diameter; ++j) {
+				auto dy = qpl::signed_cast(j) - qpl::signed_cast(radius);
+				buffer.offsets[j] = qpl::size_cast(qpl::abs(dy) / 2 + (((dy % 2) && (y % 2)) ? 1 : 0));
+				buffer.widths[j] = diameter - qpl::size_cast(qpl::abs(dy));
+			}
+
+			std::fill(buffer.neighbours.begin(), buffer.neighbours.end(), neighbours_uint{ 0 });
+			for (qpl::size j = 0u; j < diameter; ++j) {
+				const auto* row = buffer.halo.data() + (ly + j) * halo_width + buffer.offsets[j];
+				for (qpl::size i = 0u; i < buffer.widths[j]; ++i) {
+					++buffer.neighbours[row[i]];
+				}
+			}
+
+			auto index = y * this->dimension.x + block.position.x;
+			for (qpl::size lx = 0u; lx < block.dimension.x; ++lx, ++index) {
+				if (lx) {
+					for (qpl::size j = 0u; j < diameter; ++j) {
+						const auto* row = buffer.halo.data() + (ly + j) * halo_width + buffer.offsets[j] + lx - 1;
+						--buffer.neighbours[row[0]];
+						++buffer.neighbours[row[buffer.widths[j]]];
+					}
+				}
+
+				auto target = this->collection[index];
+				--buffer.neighbours[target];
+				auto result = member_rule.get(target, buffer.neighbours);
+				++buffer.neighbours[target];
+
+				this->next[index] = result;
+				++statistics.population[result];
+				statistics.changed += (result != target);
+			}
+		}
+	}
 
-		return result;
+	void udpate(bool parallel = true) {
+		this->next.resize(this->collection.size());
+
+		auto& pool = worker_pool::get();
+		auto thread_size = (parallel && this->blocks.size() > 1u) ? pool.size() : qpl::size{ 1u };
+		this->buffers.resize(thread_size);
+		for (auto& buffer : this->buffers) {
+			buffer.statistics.resize(this->member_size());
+			for (auto& statistics : buffer.statistics) {
+				statistics.clear();
+			}
+		}
+
+		std::atomic_size_t block_index = 0u;
+		auto work = [&](kernel_buffer& buffer) {
+			while (true) {
+				auto index = block_index++;
+				if (index >= this->blocks.size()) {
+					break;
+				}
+				this->update_block(this->blocks[index], buffer);
+			}
+		};
+
+		if (thread_size == 1u) {
+			work(this->buffers.front());
+		}
+		else {
+			pool.run([&](qpl::size index) {
+				work(this->buffers[index]);
+			});
+		}
+		this->collection.swap(this->next);
+		this->merge_statistics();
+	}
+
+	void merge_statistics() {
+		this->member_statistics.resize(this->member_size());
+		this->statistics.clear();
+		for (qpl::size member = 0u; member < this->member_size(); ++member) {
+			auto& statistics = this->member_statistics[member];
+			statistics.clear();
+			for (const auto& buffer : this->buffers) {
+				statistics.add(buffer.statistics[member]);
+			}
+			this->statistics.add(statistics);
+		}
+	}
+	void clear_statistics() {
+		this->member_statistics.clear();
+		this->statistics.clear();
 	}
-	void udpate() {
-		auto copy = this->collection;
-		for (qpl::isize y = 0; y < qpl::signed_cast(this->dimension.y); ++y) {
-			for (qpl::isize x = 0; x < qpl::signed_cast(this->dimension.x); ++x) {
-				auto neighbours = this->count_neighbours(x, y);
 
-				auto& target = copy[y * this->dimension.x + x];
-				target = rule.get(target, neighbours);
+	//the plain row by row step, kept as reference for the blocked kernel
+	void udpate_row_order() {
+		this->next.resize(this->collection.size());
+		std::vector<neighbours_uint> neighbours(info::state_size, 0);
+
+		for (qpl::size member = 0u; member < this->member_size(); ++member) {
+			const auto& member_rule = this->get_rule(member);
+			auto position = this->member_position(member);
+
+			for (qpl::size y = position.y; y < position.y + this->member_dimension.y; ++y) {
+				for (qpl::size x = position.x; x < position.x + this->member_dimension.x; ++x) {
+					this->count_neighbours(neighbours, qpl::signed_cast(x), qpl::signed_cast(y), member);
+
+					auto index = y * this->dimension.x + x;
+					this->next[index] = member_rule.get(this->collection[index], neighbours);
+				}
 			}
 		}
-		this->collection = copy;
+		this->collection.swap(this->next);
 	}
 
 	void clear() {
 		this->collection.clear();
 	}
-	void create(qpl::vec2s size) {
-		this->dimension = size;
+	void create(qpl::vec2s size, qpl::size ensemble_size = 1u) {
+		this->ensemble_size = qpl::max(ensemble_size, qpl::size{ 1u });
+		this->member_dimension.x = qpl::max(size.x / this->ensemble_size, qpl::size{ 1u });
+		this->member_dimension.y = qpl::max(size.y / this->ensemble_size, qpl::size{ 1u });
+
+		//odd rows are shifted, so members only share the neighbourhood layout of a grid of their own if they start on even rows
+		if (this->ensemble_size > 1u && this->member_dimension.y > 1u) {
+			this->member_dimension.y -= this->member_dimension.y % 2u;
+		}
+		this->dimension.x = this->member_dimension.x * this->ensemble_size;
+		this->dimension.y = this->member_dimension.y * this->ensemble_size;
 
-		this->collection.resize(size.x * size.y);
+		this->collection.resize(this->dimension.x * this->dimension.y);
+		this->member_rules.clear();
+		this->make_blocks();
+		this->clear_statistics();
 	}
 	void reset() {
 		std::fill(this->collection.begin(), this->collection.end(), undefined);
 	}
+	//only the filled cells are drawn, the gaps between them follow a geometric distribution
+	void randomize() {
+		std::fill(this->collection.begin(), this->collection.end(), hexagon{ 0 });
+		auto chance = 1.0 / std::pow(10, info::random_fill_chance);
+		if (chance >= 1.0) {
+			for (auto& i : this->collection) {
+				i = qpl::random(0u, info::state_size - 1);
+			}
+			return;
+		}
+
+		auto log = std::log(1.0 - chance);
+		qpl::size index = 0u;
+		while (index < this->collection.size()) {
+			auto gap = std::floor(std::log(1.0 - qpl::random(0.0, 1.0)) / log);
+			if (!(gap < qpl::f64_cast(this->collection.size() - index))) {
+				break;
+			}
+			index += qpl::size_cast(gap);
+			this->collection[index] = qpl::random(0u, info::state_size - 1);
+			++index;
+		}
+	}
 };
 
-struct hexagon_shape {
-	std::array<qpl::vec2, 18> vertices;
+//evolves mutants of a seed rule. every generation the whole population is evaluated as one headless ensemble,
+//so the members are stepped in parallel by the blocked kernel. each candidate runs on several seeds,
+//and all candidates of a generation share the same seeds
+struct rule_optimiser {
+	struct candidate {
+		rule rule;
+		qpl::f64 fitness = 0.0;
+	};
+
+	constexpr static qpl::size candidates = 16u;
+	constexpr static qpl::size seeds = 4u;
+	constexpr static qpl::size ensemble_size = 8u;
+	constexpr static qpl::size member_dimension = 64u;
+	constexpr static qpl::size steps = 200u;
+	constexpr static qpl::size survivors = 4u;
+	constexpr static qpl::f64 max_activity = 0.25;
+	static_assert(candidates * seeds == ensemble_size * ensemble_size);
+
+	rule seed;
+	std::vector<candidate> population;
+	candidate best;
+	qpl::size generation = 0u;
+	std::string checkpoint_file;
+	hexagons grid;
+	std::future<std::vector<qpl::f64>> pending;
+	std::atomic_bool cancelled = false;
+	bool running = false;
+
+	~rule_optimiser() {
+		this->stop();
+	}
+
+	//a member scores for every step it keeps changing without turning into noise.
+	//calm, dense members score slightly higher, which favours persistent structures
+	static qpl::f64 score(const population_statistics& statistics) {
+		auto activity = statistics.activity();
+		if (activity > max_activity) {
+			return 0.0;
+		}
+		return 1.0 + statistics.density() * (1.0 - activity / max_activity);
+	}
+
+	std::vector<qpl::f64> evaluate() {
+		std::vector<qpl::f64> fitness(this->grid.member_size(), 0.0);
+		std::vector<bool> alive(this->grid.member_size(), true);
+		for (qpl::size step = 0u; step < steps && !this->cancelled; ++step) {
+			this->grid.udpate();
+			for (qpl::size member = 0u; member < this->grid.member_size(); ++member) {
+				if (!alive[member]) {
+					continue;
+				}
+				const auto& statistics = this->grid.member_statistics[member];
+				if (statistics.collapsed()) {
+					alive[member] = false;
+					continue;
+				}
+				fitness[member] += score(statistics);
+			}
+		}
+		return fitness;
+	}
+
+	//seeding and mutating use qpl::random, so they stay on the calling thread and only the stepping runs async.
+	//member candidate * seeds + seed runs the candidate on that seed
+	void evaluate_next() {
+		this->grid.create(qpl::vec2s::filled(member_dimension * ensemble_size), ensemble_size);
+		this->grid.member_rules.resize(this->grid.member_size());
+		for (qpl::size member = 0u; member < this->grid.member_size(); ++member) {
+			this->grid.member_rules[member] = this->population[member / seeds].rule;
+		}
+
+		this->grid.randomize();
+		for (qpl::size seed = 0u; seed < seeds; ++seed) {
+			auto cells = this->grid.get_member(seed);
+			for (qpl::size candidate = 1u; candidate < this->population.size(); ++candidate) {
+				this->grid.set_member(candidate * seeds + seed, cells);
+			}
+		}
+
+		this->cancelled = false;
+		this->pending = std::async(std::launch::async, &rule_optimiser::evaluate, this);
+	}
+
+	void start(const rule& rule) {
+		this->stop();
+		this->seed = rule;
+		this->generation = 0u;
+		this->best.rule = rule;
+		this->best.fitness = 0.0;
+		std::filesystem::create_directories("checkpoints");
+		this->checkpoint_file = qpl::to_string("checkpoints/", qpl::get_current_time_string_ymdhmsms_compact(), "_optimiser.checkpoint");
+
+		this->population.resize(candidates);
+		for (qpl::size i = 0u; i < this->population.size(); ++i) {
+			this->population[i].rule = rule;
+			this->population[i].fitness = 0.0;
+			if (i) {
+				this->population[i].rule.mutate();
+			}
+		}
+		this->running = true;
+		this->evaluate_next();
+	}
+	void stop() {
+		this->cancelled = true;
+		if (this->pending.valid()) {
+			this->pending.wait();
+			this->pending.get();
+		}
+		this->running = false;
+	}
 
+	//the population always starts with the best rule so far, which is scored again on the seeds of every generation.
+	//the next population is that rule, the fittest other candidates and mutants of them. returns true if a new best rule was found
+	bool poll() {
+		if (!this->pending.valid() || this->pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return false;
+		}
+		auto fitness = this->pending.get();
+		for (qpl::size i = 0u; i < this->population.size(); ++i) {
+			this->population[i].fitness = 0.0;
+			for (qpl::size seed = 0u; seed < seeds; ++seed) {
+				this->population[i].fitness += fitness[i * seeds + seed];
+			}
+			this->population[i].fitness /= seeds;
+		}
+		this->best.fitness = this->population.front().fitness;
+
+		std::stable_sort(this->population.begin(), this->population.end(), [](const auto& a, const auto& b) {
+			return a.fitness > b.fitness;
+		});
+
+		bool improved = this->population.front().fitness > this->best.fitness && !(this->population.front().rule == this->best.rule);
+		if (improved) {
+			this->best = this->population.front();
+		}
+
+		std::vector<candidate> next{ this->best };
+		for (const auto& i : this->population) {
+			if (next.size() == survivors) {
+				break;
+			}
+			if (!(i.rule == this->best.rule)) {
+				next.push_back(i);
+			}
+		}
+		auto parents = next.size();
+		while (next.size() < candidates) {
+			auto child = next[next.size() % parents];
+			child.fitness = 0.0;
+			auto mutations = qpl::random(1u, 3u);
+			for (qpl::size m = 0u; m < mutations; ++m) {
+				child.rule.mutate();
+			}
+			next.push_back(child);
+		}
+		this->population = std::move(next);
+
+		++this->generation;
+		qpl::println("generation ", this->generation, " best fitness ", this->best.fitness, (improved ? " (new)" : ""));
+
+		this->save(this->checkpoint_file);
+		this->evaluate_next();
+		return improved;
+	}
+
+	void save(std::string file) const {
+		qpl::save_state state;
+		state.save(info::state_size);
+		state.save(info::neighbours_radius);
+		this->seed.save(state);
+		state.save(this->generation);
+		state.save(this->best.fitness);
+		this->best.rule.save(state);
+		state.save(this->population.size());
+		for (auto& i : this->population) {
+			state.save(i.fitness);
+			i.rule.save(state);
+		}
+		state.file_save(file);
+	}
+	//only loads the checkpoint if the rule is its seed or its best rule and it was saved with the current settings,
+	//the settings of the running session are never changed
+	bool load(std::string file, const rule& rule) {
+		qpl::load_state state;
+		state.file_load(file);
+
+		decltype(info::state_size) state_size;
+		decltype(info::neighbours_radius) neighbours_radius;
+		state.load(state_size);
+		state.load(neighbours_radius);
+		if (state_size != info::state_size || neighbours_radius != info::neighbours_radius) {
+			return false;
+		}
+		this->seed.load(state);
+		state.load(this->generation);
+		state.load(this->best.fitness);
+		this->best.rule.load(state);
+		if (!(this->seed == rule) && !(this->best.rule == rule)) {
+			return false;
+		}
+
+		qpl::size size;
+		state.load(size);
+		this->population.resize(size);
+		for (auto& i : this->population) {
+			state.load(i.fitness);
+			i.rule.load(state);
+		}
+		return true;
+	}
+
+	//the names start with the time of the search, so they sort oldest first
+	static std::vector<std::string> checkpoint_files() {
+		std::vector<std::string> result;
+		if (!std::filesystem::exists("checkpoints")) {
+			return result;
+		}
+		qpl::filesys::path path = qpl::to_string(qpl::filesys::get_current_location(), "/checkpoints/");
+		auto files = path.list_current_directory();
+		files.list_keep_where_extension_equals(".checkpoint");
+
+		for (qpl::size i = 0u; i < files.size(); ++i) {
+			result.push_back(files[i]);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+	//a checkpoint that can't be read, e.g. one cut short while saving, is skipped
+	bool try_load(std::string file, const rule& rule) {
+		try {
+			return this->load(file, rule);
+		}
+		catch (std::exception& any) {
+			qpl::println("skipped optimiser checkpoint \"", file, "\": ", any.what());
+			return false;
+		}
+	}
+	//continues the newest search that was started from the rule or found it, and keeps writing to its checkpoint
+	bool resume(const rule& rule) {
+		this->stop();
+		auto files = checkpoint_files();
+		for (auto it = files.rbegin(); it != files.rend(); ++it) {
+			if (this->try_load(*it, rule)) {
+				this->checkpoint_file = *it;
+				this->population.resize(candidates, this->best);
+				this->population.front() = this->best;
+				this->running = true;
+				this->evaluate_next();
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+struct hexagon_shape {
 	constexpr static auto size = qpl::vec(50, 50);
 	constexpr static auto hex_scale = qpl::sqrt(3.0) / 2;
-	void create(qpl::vector2i position) {
-		std::array<qpl::vec2, 6> angles{};
 
+	//the 18 vertices of a hexagon relative to its center. the trigonometry is only computed once
+	static const std::array<qpl::vec2, 18>& unit_vertices() {
+		static const auto result = [] {
+			std::array<qpl::vec2, 6> angles{};
+			for (qpl::size i = 0u; i < 6u; ++i) {
+				auto angle = 2 * qpl::pi * ((i + 0.5) / 6.0);
+				auto x = std::cos(angle);
+				auto y = std::sin(angle);
+				angles[i] = qpl::vec(x, y) * (hexagon_shape::size * 0.5);
+			}
+
+			std::array<qpl::vec2, 18> vertices{};
+			for (qpl::size i = 0u; i < 6u; ++i) {
+				vertices[i * 3u + 0] = qpl::vec(0.0, 0.0);
+				for (qpl::size k = 1u; k < 3u; ++k) {
+					vertices[i * 3u + k] = angles[(i + k) % angles.size()];
+				}
+			}
+			return vertices;
+		}();
+		return result;
+	}
+	static qpl::vec2 center(qpl::vector2i position) {
 		constexpr auto scale = hexagon_shape::size * qpl::vec(hex_scale, 0.75);
 		auto center = position * scale;
 
 		if (position.y % 2) {
 			center.x += scale.x / 2;
 		}
-		for (qpl::size i = 0u; i < 6u; ++i) {
-			auto angle = 2 * qpl::pi * ((i + 0.5) / 6.0);
-			auto x = std::cos(angle);
-			auto y = std::sin(angle);
-			angles[i] = qpl::vec(x, y) * (hexagon_shape::size * 0.5);
-		}
-
-		for (qpl::size i = 0u; i < 6u; ++i) {
-			vertices[i * 3u + 0] = center;
-			for (qpl::size k = 1u; k < 3u; ++k) {
-				vertices[i * 3u + k] = angles[(i + k) % angles.size()] + center;
-			}
-		}
+		return center;
 	}
 };
 
-struct hexagons_graphic {
+//the view is drawn with its render states, so their inverse transform maps a screen position back into the world
+qpl::vec2 screen_to_world(const qsf::view_control& view, qpl::vec2 position) {
+	auto point = view.get_render_states().transform.getInverse().transformPoint(sf::Vector2f(position.x, position.y));
+	return qpl::vec(point.x, point.y);
+}
+
+enum class level_of_detail {
+	hexagons,
+	cells,
+	samples,
+};
+
+//a rectangle of cells in one level of detail: 18 vertices per hexagon, a quad per cell
+//or a quad per sample_size x sample_size cells colored by its top left cell
+struct hexagon_chunk {
 	qsf::vertex_array va;
+	qpl::vec2s position;
+	qpl::vec2s dimension;
+	qpl::vec2 min;
+	qpl::vec2 max;
+};
+
+struct hexagons_graphic {
+	std::vector<hexagon_chunk> chunks;
 	hexagons before;
 
 	std::vector<qpl::f64> heatmap;
 
+	std::future<std::vector<hexagon_chunk>> pending;
+	std::shared_ptr<std::atomic_bool> pending_cancel;
+	std::vector<hexagon> pending_states;
+	std::vector<qpl::rgb> pending_colors;
+
+	level_of_detail level = level_of_detail::hexagons;
+	level_of_detail target_level = level_of_detail::hexagons;
+	level_of_detail pending_level = level_of_detail::hexagons;
+	bool pending_resize = false;
+	bool culling = false;
+	qpl::vec2 visible_min;
+	qpl::vec2 visible_max;
+
 	constexpr static auto use_heatmap = false;
+	constexpr static qpl::size ensemble_gap = 2u;
+	constexpr static qpl::size chunk_size = 64u;
+	constexpr static qpl::size sample_size = 4u;
+	constexpr static qpl::f64 cells_below_pixels = 4.0;
+	constexpr static qpl::f64 samples_below_pixels = 1.0;
 	bool created = false;
 
-	hexagons_graphic() {
-		this->va.set_primitive_type(qsf::primitive_type::triangles);
+	~hexagons_graphic() {
+		this->cancel();
+	}
+
+	static void set_quad(qsf::vertex_array& va, qpl::size index, qpl::vec2 min, qpl::vec2 max, qpl::rgb color) {
+		std::array<qpl::vec2, 6> corners = {
+			min, qpl::vec(max.x, min.y), max,
+			min, max, qpl::vec(min.x, max.y)
+		};
+		for (qpl::size i = 0u; i < corners.size(); ++i) {
+			va[index * 6u + i].position = corners[i];
+			va[index * 6u + i].color = color;
+		}
 	}
 
-	void create(qpl::vec2s size) {
-		auto dim = size.x * size.y;
+	//ensemble members are spaced apart by an even gap so the row parity of the hexagons is kept
+	static qpl::size member_gap(const hexagons& hexagons) {
+		return hexagons.ensemble_size > 1u ? ensemble_gap : 0u;
+	}
+	static qpl::vec2 cell_center(qpl::size x, qpl::size y, qpl::vec2s member_dimension, qpl::size gap) {
+		qpl::vector2i position;
+		position.x = qpl::i32_cast(x + (x / member_dimension.x) * gap);
+		position.y = qpl::i32_cast(y + (y / member_dimension.y) * gap);
+		return hexagon_shape::center(position);
+	}
+	//the ensemble member drawn at the world position, or member_size() if there is none
+	static qpl::size member_at(const hexagons& hexagons, qpl::vec2 position) {
+		auto gap = member_gap(hexagons);
+		qpl::vec2 radius = hexagon_shape::size * 0.5;
+		for (qpl::size member = 0u; member < hexagons.member_size(); ++member) {
+			auto first = hexagons.member_position(member);
+			auto min = cell_center(first.x, first.y, hexagons.member_dimension, gap);
+			auto max = cell_center(first.x + hexagons.member_dimension.x - 1, first.y + hexagons.member_dimension.y - 1, hexagons.member_dimension, gap);
+			if (position.x >= min.x - radius.x && position.x <= max.x + radius.x && position.y >= min.y - radius.y && position.y <= max.y + radius.y) {
+				return member;
+			}
+		}
+		return hexagons.member_size();
+	}
 
-		hexagon_shape hex;
-		this->va.resize(dim * hex.vertices.size());
-		this->heatmap.resize(dim, 0.0);
+	//runs off the UI thread and only builds the requested level of detail, already colored by the given states.
+	//every vertex of the hexagons level is the cached unit hexagon moved to the cell center
+	static std::vector<hexagon_chunk> build(qpl::vec2s size, qpl::vec2s member_dimension, qpl::size gap, level_of_detail level,
+		std::vector<hexagon> states, std::vector<qpl::rgb> colors, std::shared_ptr<std::atomic_bool> cancel) {
+
+		const auto& unit = hexagon_shape::unit_vertices();
+		qpl::vec2 radius = hexagon_shape::size * 0.5;
+		qpl::vec2 half = hexagon_shape::size * qpl::vec(hexagon_shape::hex_scale, 0.75) * 0.5;
+
+		auto center = [&](qpl::size x, qpl::size y) {
+			return cell_center(x, y, member_dimension, gap);
+		};
+		auto color = [&](qpl::size x, qpl::size y) {
+			auto state = states[y * size.x + x];
+			return state < colors.size() ? colors[state] : qpl::rgb::white();
+		};
+
+		std::vector<hexagon_chunk> chunks;
+		for (qpl::size cy = 0u; cy < size.y; cy += chunk_size) {
+			for (qpl::size cx = 0u; cx < size.x; cx += chunk_size) {
+				if (*cancel) {
+					return chunks;
+				}
+				hexagon_chunk chunk;
+				chunk.position.x = cx;
+				chunk.position.y = cy;
+				chunk.dimension.x = qpl::min(chunk_size, size.x - cx);
+				chunk.dimension.y = qpl::min(chunk_size, size.y - cy);
+
+				auto samples_x = (chunk.dimension.x + sample_size - 1) / sample_size;
+				auto samples_y = (chunk.dimension.y + sample_size - 1) / sample_size;
+				chunk.va.set_primitive_type(qsf::primitive_type::triangles);
+				if (level == level_of_detail::hexagons) {
+					chunk.va.resize(chunk.dimension.x * chunk.dimension.y * unit.size());
+				}
+				else if (level == level_of_detail::cells) {
+					chunk.va.resize(chunk.dimension.x * chunk.dimension.y * 6u);
+				}
+				else {
+					chunk.va.resize(samples_x * samples_y * 6u);
+				}
 
-		qpl::size ctr = 0u;
-		for (auto vec : size.list_possibilities_range()) {
-			hex.create(vec);
-			for (qpl::size i = 0u; i < hex.vertices.size(); ++i) {
-				this->va[ctr * hex.vertices.size() + i].position = hex.vertices[i];
-				this->va[ctr * hex.vertices.size() + i].color = qpl::rgb::white();
+				chunk.min = center(cx, cy);
+				chunk.max = chunk.min;
+				for (qpl::size ly = 0u; ly < chunk.dimension.y; ++ly) {
+					for (qpl::size lx = 0u; lx < chunk.dimension.x; ++lx) {
+						auto x = cx + lx;
+						auto y = cy + ly;
+						auto position = center(x, y);
+						auto index = ly * chunk.dimension.x + lx;
+
+						if (level == level_of_detail::hexagons) {
+							auto cell_color = color(x, y);
+							for (qpl::size i = 0u; i < unit.size(); ++i) {
+								chunk.va[index * unit.size() + i].position = unit[i] + position;
+								chunk.va[index * unit.size() + i].color = cell_color;
+							}
+						}
+						else if (level == level_of_detail::cells) {
+							set_quad(chunk.va, index, position - half, position + half, color(x, y));
+						}
+						else if (!(lx % sample_size) && !(ly % sample_size)) {
+							auto last = center(qpl::min(x + sample_size, cx + chunk.dimension.x) - 1, qpl::min(y + sample_size, cy + chunk.dimension.y) - 1);
+							set_quad(chunk.va, (ly / sample_size) * samples_x + lx / sample_size, position - half, last + half, color(x, y));
+						}
+
+						chunk.min.x = qpl::min(chunk.min.x, position.x - radius.x);
+						chunk.min.y = qpl::min(chunk.min.y, position.y - radius.y);
+						chunk.max.x = qpl::max(chunk.max.x, position.x + radius.x);
+						chunk.max.y = qpl::max(chunk.max.y, position.y + radius.y);
+					}
+				}
+				chunks.push_back(std::move(chunk));
 			}
-			++ctr;
 		}
+		return chunks;
+	}
+
+	void cancel() {
+		if (this->pending_cancel) {
+			*this->pending_cancel = true;
+		}
+		if (this->pending.valid()) {
+			this->pending.wait();
+		}
+	}
+	bool building() const {
+		return this->pending.valid();
+	}
+
+	//builds the chunks of target_level for the dimension of before, colored by the current states of before.
+	//a cancelled resize stays pending with the new build, since the current chunks no longer match the grid
+	void start_build() {
+		this->cancel();
+
+		this->pending_level = this->target_level;
+		this->pending_states = this->before.collection;
+		this->pending_colors = info::state_colors;
+		this->pending_cancel = std::make_shared<std::atomic_bool>(false);
+		this->pending = std::async(std::launch::async, &hexagons_graphic::build, this->before.dimension, this->before.member_dimension, member_gap(this->before),
+			this->pending_level, this->pending_states, this->pending_colors, this->pending_cancel);
+	}
+	void create(const hexagons& hexagons) {
+		this->before.create(hexagons.dimension, hexagons.ensemble_size);
+		this->before.collection = hexagons.collection;
+		this->pending_resize = true;
 		this->created = true;
+		this->start_build();
+	}
+	bool finish_create() {
+		if (this->pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return false;
+		}
+		this->chunks = this->pending.get();
+		this->level = this->pending_level;
+		if (this->pending_resize) {
+			this->heatmap.assign(this->before.size(), 0.0);
+			this->pending_resize = false;
+		}
+
+		//the new chunks show the snapshot, so only cells that changed since then are written again
+		this->before.collection = std::move(this->pending_states);
+		if (this->pending_colors != info::state_colors) {
+			this->before.reset();
+		}
+		return true;
+	}
+
+	//picks the level of detail from the on screen size of a hexagon and remembers the visible area for culling.
+	//only the chunks of one level are kept, a change of level builds the new one asynchronously
+	void set_view(const qsf::view_control& view, qpl::vec2 screen) {
+		auto a = screen_to_world(view, qpl::vec(0.0, 0.0));
+		auto b = screen_to_world(view, screen);
+		this->visible_min.x = qpl::min(a.x, b.x);
+		this->visible_min.y = qpl::min(a.y, b.y);
+		this->visible_max.x = qpl::max(a.x, b.x);
+		this->visible_max.y = qpl::max(a.y, b.y);
+		this->culling = true;
+
+		auto visible_width = qpl::f64_cast(this->visible_max.x - this->visible_min.x);
+		auto pixels = visible_width > 0 ? screen.x / visible_width * hexagon_shape::size.x * hexagon_shape::hex_scale : cells_below_pixels;
+
+		auto level = level_of_detail::hexagons;
+		if (pixels < samples_below_pixels) {
+			level = level_of_detail::samples;
+		}
+		else if (pixels < cells_below_pixels) {
+			level = level_of_detail::cells;
+		}
+		this->target_level = level;
+		if (this->created && this->target_level != (this->building() ? this->pending_level : this->level)) {
+			this->start_build();
+		}
 	}
 
 	void set(qpl::size index, qpl::rgb color) {
-		for (qpl::size i = 0u; i < 18u; ++i) {
-			this->va[index * 18 + i].color = color;
+		auto x = index % this->before.dimension.x;
+		auto y = index / this->before.dimension.x;
+		auto columns = (this->before.dimension.x + chunk_size - 1) / chunk_size;
+		auto& chunk = this->chunks[(y / chunk_size) * columns + (x / chunk_size)];
+		auto lx = x - chunk.position.x;
+		auto ly = y - chunk.position.y;
+
+		qpl::size vertices = 6u;
+		auto local = ly * chunk.dimension.x + lx;
+		if (this->level == level_of_detail::hexagons) {
+			vertices = 18u;
+		}
+		else if (this->level == level_of_detail::samples) {
+			if ((lx % sample_size) || (ly % sample_size)) {
+				return;
+			}
+			local = (ly / sample_size) * ((chunk.dimension.x + sample_size - 1) / sample_size) + lx / sample_size;
+		}
+
+		for (qpl::size i = 0u; i < vertices; ++i) {
+			chunk.va[local * vertices + i].color = color;
 		}
 	}
 	void set(qpl::size index) {
 		this->heatmap[index] += 0.1;
 	}
 	void set(qpl::size index, hexagon hexagon) {
-		for (qpl::size i = 0u; i < 18u; ++i) {
-			this->va[index * 18 + i].color = info::state_colors[hexagon];
-		}
+		this->set(index, info::state_colors[hexagon]);
 	}
 
 	void update(const hexagons& hexagons) {
-		if (!this->created) {
-			this->before.clear();
-			this->create(hexagons.dimension);
+		if (!this->created || hexagons.dimension != before.dimension || hexagons.ensemble_size != before.ensemble_size) {
+			this->create(hexagons);
 		}
 
-		if (hexagons.dimension != before.dimension) {
-			this->create(hexagons.dimension);
-			before.dimension = hexagons.dimension;
-			before.create(hexagons.dimension);
-			before.reset();
+		//the previous chunks keep being drawn until the new ones are built. after a resize they
+		//no longer match the grid, otherwise they keep being updated in their own level
+		if (this->building() && !this->finish_create() && this->pending_resize) {
+			return;
 		}
 		for (qpl::size i = 0u; i < hexagons.size(); ++i) {
 			if (this->before[i] != hexagons[i]) {
@@ -397,8 +1308,71 @@ struct hexagons_graphic {
 		}
 	}
 
+	void draw(qsf::draw_object& draw) const {
+		for (const auto& chunk : this->chunks) {
+			if (this->culling && (chunk.max.x < this->visible_min.x || chunk.min.x > this->visible_max.x ||
+				chunk.max.y < this->visible_min.y || chunk.min.y > this->visible_max.y)) {
+				continue;
+			}
+			draw.draw(chunk.va);
+		}
+	}
+};
+
+struct statistics_graphic {
+	qsf::vertex_array va;
+	qsf::text text;
+	qpl::vec2 position = qpl::vec(650, 50);
+	qpl::vec2 dimension = qpl::vec(400, 100);
+
+	statistics_graphic() {
+		this->va.set_primitive_type(qsf::primitive_type::triangles);
+	}
+
+	void init() {
+		this->text.set_font("helvetica");
+		this->text.set_character_size(12);
+		this->text.set_color(qpl::rgb::grey_shade(150));
+		auto text_position = this->position;
+		text_position.y += this->dimension.y + 5;
+		this->text.set_position(text_position);
+	}
+
+	//one bar per state, the empty state 0 is left out since it would dwarf all others
+	void update(const population_statistics& statistics) {
+		auto size = statistics.population.size();
+		this->va.resize(size * 6u);
+
+		qpl::size max = 0u;
+		for (qpl::size i = 1u; i < size; ++i) {
+			max = qpl::max(max, statistics.population[i]);
+		}
+
+		auto width = qpl::f64_cast(this->dimension.x) / qpl::max(size, qpl::size{ 1u });
+		for (qpl::size i = 0u; i < size; ++i) {
+			auto height = (i && max) ? this->dimension.y * (qpl::f64_cast(statistics.population[i]) / max) : 0.0;
+			auto left = qpl::f64_cast(this->position.x) + i * width;
+			auto bottom = qpl::f64_cast(this->position.y + this->dimension.y);
+
+			std::array<qpl::vec2, 6> corners = {
+				qpl::vec(left, bottom - height), qpl::vec(left + width, bottom - height), qpl::vec(left + width, bottom),
+				qpl::vec(left, bottom - height), qpl::vec(left + width, bottom), qpl::vec(left, bottom)
+			};
+			for (qpl::size c = 0u; c < corners.size(); ++c) {
+				this->va[i * 6u + c].position = corners[c];
+				this->va[i * 6u + c].color = i < info::state_colors.size() ? info::state_colors[i] : qpl::rgb::white();
+			}
+		}
+
+		this->text.set_string(qpl::to_string(
+			"changed: ", statistics.changed,
+			"  activity: ", qpl::percentage_string(statistics.activity()),
+			"  density: ", qpl::percentage_string(statistics.density())));
+	}
+
 	void draw(qsf::draw_object& draw) const {
 		draw.draw(this->va);
+		draw.draw(this->text);
 	}
 };
 
@@ -411,7 +1385,7 @@ struct main_state : qsf::base_state {
 
 		this->call_on_resize();
 
-		this->hexagons.create(info::hexagons_dimension);
+		this->hexagons.create(info::hexagons_dimension, info::ensemble_size);
 		this->graphic.update(this->hexagons);
 
 		this->next_random_rule();
@@ -426,6 +1400,8 @@ struct main_state : qsf::base_state {
 		this->checkbox_switch_states.set_position({ 650, 20 });
 		this->checkbox_switch_states.set_value(info::remove_switch_states);
 
+		this->statistics_graphic.init();
+
 		this->slider_empty_rule.set_text_font("helvetica");
 		this->slider_empty_rule.set_text_character_size(12);
 		this->slider_empty_rule.set_text_color(qpl::rgb::grey_shade(150));
@@ -467,6 +1443,12 @@ struct main_state : qsf::base_state {
 		this->slider_dimension.set_position({ 20, width + (slider_ctr++) * (width + increase) });
 		this->slider_dimension.set_range(10, 1000, 300);
 
+		this->slider_ensemble = this->slider_empty_rule;
+		this->slider_ensemble.set_text_string("ensemble: ");
+		this->slider_ensemble.set_text_string_function([](auto s) {return qpl::to_string(s, " x ", s); });
+		this->slider_ensemble.set_position({ 20, width + (slider_ctr++) * (width + increase) });
+		this->slider_ensemble.set_range(1, 8, info::ensemble_size);
+
 		this->slider_empty_rule.set_text_string_function([](auto s) {return qpl::percentage_string(s); });
 		this->slider_repeated_rule_change.set_text_string_function([](auto s) {return qpl::percentage_string(s); });
 	}
@@ -480,10 +1462,15 @@ struct main_state : qsf::base_state {
 		qpl::println("'E'     - load previous rules/");
 		qpl::println("'L'     - load random rule from rules/");
 		qpl::println("'M'     - mutate current rule");
+		qpl::println("'K'     - toggle mutated rules across the ensemble");
+		qpl::println("RMB     - make the rule of the clicked ensemble member the current rule");
 		qpl::println("'P'     - print current rule");
+		qpl::println("'B'     - benchmark row order against blocked update");
 		qpl::println("'S'     - save current rule to rules/");
 		qpl::println("'R'     - randomize state again");
 		qpl::println("'X'     - toggle auto update mode");
+		qpl::println("'O'     - toggle rule optimiser starting from the current rule, which is saved to rules/");
+		qpl::println("LShift+O - resume the newest optimiser checkpoint whose seed or best rule is the current rule");
 		qpl::println("'<'     - return to previous rule");
 		qpl::println("'>'     - return to next rule");
 		qpl::println("'Space' - next random rule");
@@ -493,13 +1480,11 @@ struct main_state : qsf::base_state {
 		this->view.set_hitbox(*this);
 	}
 	void randomize_hexagons() {
-		for (auto& i : this->hexagons) {
-			i = 0u;
-			if (qpl::random_b(1.0 / (std::pow(10, info::random_fill_chance)))) {
-				i = qpl::random(0u, info::state_size - 1);
-			}
-		}
+		this->hexagons.make_member_rules();
+		this->hexagons.clear_statistics();
+		this->hexagons.randomize();
 		this->graphic.update(this->hexagons);
+		this->statistics_graphic.update(this->hexagons.statistics);
 	}
 	void next_random_rule() {
 		this->update_ctr = 0u;
@@ -520,6 +1505,124 @@ struct main_state : qsf::base_state {
 			this->previous_rule_ctr = 0u;
 		}
 	}
+	//the row order step is slow, so the number of steps shrinks with the work per step to keep the UI responsive
+	void benchmark_update() {
+		auto work = qpl::f64_cast(this->hexagons.size()) * info::neighbours_size;
+		auto steps = qpl::size_cast(std::clamp(2e8 / work, 1.0, 10.0));
+		qpl::println("benchmark ", this->hexagons.dimension.x, " x ", this->hexagons.dimension.y, " radius ", info::neighbours_radius, " (", steps, " steps) ...");
+
+		auto rows = this->hexagons;
+		auto single = this->hexagons;
+		auto parallel = this->hexagons;
+
+		qpl::clock clock;
+		for (qpl::size i = 0u; i < steps; ++i) {
+			rows.udpate_row_order();
+		}
+		auto row_time = clock.elapsed_f();
+
+		clock.reset();
+		for (qpl::size i = 0u; i < steps; ++i) {
+			single.udpate(false);
+		}
+		auto single_time = clock.elapsed_f();
+
+		clock.reset();
+		for (qpl::size i = 0u; i < steps; ++i) {
+			parallel.udpate();
+		}
+		auto parallel_time = clock.elapsed_f();
+
+		qpl::println("row order           : ", row_time / steps, "s per step");
+		qpl::println("blocked, 1 thread   : ", single_time / steps, "s per step, speedup ", row_time / single_time);
+		qpl::println("blocked, ", worker_pool::get().size(), " threads : ", parallel_time / steps, "s per step, speedup ", row_time / parallel_time);
+		qpl::println("identical : ", qpl::bool_string(rows.collection == single.collection && rows.collection == parallel.collection));
+
+		if (this->hexagons.member_size() > 1u) {
+			this->benchmark_ensemble(steps);
+		}
+	}
+	//compares one step of the whole ensemble against stepping every member as a grid of its own
+	void benchmark_ensemble(qpl::size steps) {
+		auto ensemble = this->hexagons;
+		std::vector<::hexagons> separate(this->hexagons.member_size());
+		for (qpl::size member = 0u; member < separate.size(); ++member) {
+			separate[member].create(this->hexagons.member_dimension);
+			separate[member].rule = this->hexagons.get_rule(member);
+			separate[member].collection = this->hexagons.get_member(member);
+		}
+
+		qpl::clock clock;
+		for (qpl::size i = 0u; i < steps; ++i) {
+			for (auto& grid : separate) {
+				grid.udpate();
+			}
+		}
+		auto separate_time = clock.elapsed_f();
+
+		clock.reset();
+		for (qpl::size i = 0u; i < steps; ++i) {
+			ensemble.udpate();
+		}
+		auto ensemble_time = clock.elapsed_f();
+
+		bool identical = true;
+		for (qpl::size member = 0u; member < separate.size(); ++member) {
+			identical = identical && ensemble.get_member(member) == separate[member].collection;
+		}
+		qpl::println(separate.size(), " separate grids : ", separate_time / steps, "s per step");
+		qpl::println("one ensemble      : ", ensemble_time / steps, "s per step, speedup ", separate_time / ensemble_time, " identical : ", qpl::bool_string(identical));
+	}
+	void toggle_optimiser() {
+		if (this->optimiser.running) {
+			this->stop_optimiser();
+			return;
+		}
+		if (this->event().key_holding(sf::Keyboard::LShift)) {
+			if (this->optimiser.resume(this->hexagons.rule)) {
+				qpl::println("optimiser resumed \"", this->optimiser.checkpoint_file, "\" at generation ", this->optimiser.generation);
+				this->adopt_optimiser_rule();
+			}
+			else {
+				qpl::println("no optimiser checkpoint was started from or found the current rule");
+			}
+			return;
+		}
+		this->save_rule();
+		this->optimiser.start(this->hexagons.rule);
+		qpl::println("optimiser started, checkpoints are saved to \"", this->optimiser.checkpoint_file, "\"");
+	}
+	void adopt_optimiser_rule() {
+		this->hexagons.rule = this->optimiser.best.rule;
+		if (this->previous_rule_ctr) {
+			this->rules.reset();
+		}
+		this->rules.add(this->hexagons.rule);
+		this->previous_rule_ctr = 0u;
+		this->update_ctr = 0u;
+		this->randomize_hexagons();
+	}
+	void stop_optimiser() {
+		if (this->optimiser.running) {
+			this->optimiser.stop();
+			qpl::println("optimiser stopped at generation ", this->optimiser.generation);
+		}
+	}
+	void promote_member(qpl::size member) {
+		this->hexagons.rule = this->hexagons.get_rule(member);
+		if (this->previous_rule_ctr) {
+			this->rules.reset();
+		}
+		this->rules.add(this->hexagons.rule);
+		this->previous_rule_ctr = 0u;
+		this->update_ctr = 0u;
+		qpl::println("ensemble member ", member, " is now the current rule");
+		this->randomize_hexagons();
+	}
+	void save_rule() {
+		auto file = qpl::to_string("rules/", qpl::get_current_time_string_ymdhmsms_compact(), "_rule.dat");
+		this->hexagons.rule.save(file);
+	}
 	void reset_previous_rules() {
 		this->rules.reset();
 		this->previous_rule_ctr = 0u;
@@ -545,6 +1648,7 @@ struct main_state : qsf::base_state {
 		}
 		this->first_file_index_load = false;
 
+		this->stop_optimiser();
 		qpl::println("loading \"", files[this->file_index], "\"");
 		this->hexagons.rule.load(files[this->file_index]);
 		this->rules.add(this->hexagons.rule);
@@ -567,6 +1671,7 @@ struct main_state : qsf::base_state {
 		}
 		this->first_file_index_load = false;
 
+		this->stop_optimiser();
 		qpl::println("loading \"", files[this->file_index], "\"");
 		this->hexagons.rule.load(files[this->file_index]);
 		this->rules.add(this->hexagons.rule);
@@ -584,6 +1689,7 @@ struct main_state : qsf::base_state {
 		auto index = qpl::random(0ull, files.size() - 1);
 
 		this->file_index = index;
+		this->stop_optimiser();
 		qpl::println("loading \"", files[index], "\"");
 		this->hexagons.rule.load(files[index]);
 		this->rules.add(this->hexagons.rule);
@@ -599,6 +1705,7 @@ struct main_state : qsf::base_state {
 		this->update(this->slider_state_size);
 		this->update(this->slider_neighbour_radius);
 		this->update(this->slider_dimension);
+		this->update(this->slider_ensemble);
 		this->update(this->slider_distinct_colors);
 		this->update(this->checkbox_switch_states);
 
@@ -620,12 +1727,14 @@ struct main_state : qsf::base_state {
 			this->randomize_hexagons();
 		}
 		if (this->slider_state_size.value_was_modified()) {
+			this->stop_optimiser();
 			info::state_size = qpl::u32_cast(this->slider_state_size.get_value());
 			info::make_state_colors();
 			this->reset_previous_rules();
 			this->next_random_rule();
 		}
 		if (this->slider_neighbour_radius.value_was_modified()) {
+			this->stop_optimiser();
 			info::neighbours_radius = qpl::i32_cast(this->slider_neighbour_radius.get_value());
 			info::calculate_neighbours_size();
 			this->reset_previous_rules();
@@ -633,8 +1742,16 @@ struct main_state : qsf::base_state {
 		}
 		if (this->slider_dimension.value_was_modified()) {
 			info::hexagons_dimension = qpl::vec2i::filled(this->slider_dimension.get_value());
-			this->hexagons.create(info::hexagons_dimension);
-			this->graphic.update(this->hexagons);
+			this->resize_requested = true;
+		}
+		if (this->slider_ensemble.value_was_modified()) {
+			info::ensemble_size = this->slider_ensemble.get_value();
+			this->resize_requested = true;
+		}
+		//resizing is only applied once the slider is released, the geometry is then built asynchronously
+		if (this->resize_requested && !this->slider_dimension.dragging && !this->slider_ensemble.dragging) {
+			this->resize_requested = false;
+			this->hexagons.create(info::hexagons_dimension, info::ensemble_size);
 			this->randomize_hexagons();
 		}
 		if (this->slider_distinct_colors.value_was_modified()) {
@@ -650,15 +1767,25 @@ struct main_state : qsf::base_state {
 			this->slider_state_size.dragging || 
 			this->slider_neighbour_radius.dragging ||
 			this->slider_dimension.dragging ||
+			this->slider_ensemble.dragging ||
 			this->slider_distinct_colors.dragging);
 
 		this->view.allow_dragging = !dragging;
 		this->update(this->view);
+		this->graphic.set_view(this->view, this->dimension());
 
 		if (this->update_clock.has_elapsed_reset(this->update_delta)) {
 			++this->update_ctr;
 			this->hexagons.udpate();
 			this->graphic.update(this->hexagons);
+			this->statistics_graphic.update(this->hexagons.statistics);
+		}
+		else if (this->graphic.building()) {
+			this->graphic.update(this->hexagons);
+		}
+
+		if (this->optimiser.running && this->optimiser.poll()) {
+			this->adopt_optimiser_rule();
 		}
 
 		if (this->event().key_pressed(sf::Keyboard::A)) {
@@ -680,8 +1807,10 @@ struct main_state : qsf::base_state {
 			this->load_next_file_rule();
 		}
 		else if (this->event().key_single_pressed(sf::Keyboard::S)) {
-			auto file = qpl::to_string("rules/", qpl::get_current_time_string_ymdhmsms_compact(), "_rule.dat");
-			this->hexagons.rule.save(file);
+			this->save_rule();
+		}
+		else if (this->event().key_single_pressed(sf::Keyboard::B)) {
+			this->benchmark_update();
 		}
 		else if (this->event().key_single_pressed(sf::Keyboard::P)) {
 			qpl::println(this->hexagons.rule.info_string(), "\n\n");
@@ -709,14 +1838,29 @@ struct main_state : qsf::base_state {
 			this->hexagons.rule.mutate();
 			this->randomize_hexagons();
 		}
+		else if (this->event().right_mouse_clicked() && this->hexagons.member_size() > 1u) {
+			auto position = screen_to_world(this->view, this->event().mouse_position());
+			auto member = hexagons_graphic::member_at(this->hexagons, position);
+			if (member < this->hexagons.member_size()) {
+				this->promote_member(member);
+			}
+		}
+		else if (this->event().key_single_pressed(sf::Keyboard::K)) {
+			info::ensemble_mutate = !info::ensemble_mutate;
+			qpl::println("ensemble_mutate : ", qpl::bool_string(info::ensemble_mutate));
+			this->randomize_hexagons();
+		}
 		else if (this->event().key_single_pressed(sf::Keyboard::Space)) {
 			this->next_random_rule();
 		}
+		else if (this->event().key_single_pressed(sf::Keyboard::O)) {
+			this->toggle_optimiser();
+		}
 		else if (this->event().key_single_pressed(sf::Keyboard::X)) {
 			this->auto_update = !this->auto_update;
 			qpl::println("auto_update : ", qpl::bool_string(this->auto_update));
 		}
-		else if (this->auto_update && this->update_ctr > 125) {
+		else if (this->auto_update && (this->update_ctr > 125 || this->hexagons.statistics.collapsed())) {
 			this->next_random_rule();
 		}
 		else if (this->event().key_single_pressed(sf::Keyboard::Left)) {
@@ -741,13 +1885,16 @@ struct main_state : qsf::base_state {
 			this->draw(this->slider_state_size);
 			this->draw(this->slider_neighbour_radius);
 			this->draw(this->slider_dimension);
+			this->draw(this->slider_ensemble);
 			this->draw(this->slider_distinct_colors);
 			this->draw(this->checkbox_switch_states);
+			this->draw(this->statistics_graphic);
 		}
 	}
 
 	hexagons hexagons;
 	hexagons_graphic graphic;
+	statistics_graphic statistics_graphic;
 	qsf::view_control view;
 
 	qsf::slider<qpl::f64> slider_empty_rule;
@@ -756,12 +1903,14 @@ struct main_state : qsf::base_state {
 	qsf::slider<qpl::size> slider_state_size;
 	qsf::slider<qpl::size> slider_neighbour_radius;
 	qsf::slider<qpl::size> slider_dimension;
+	qsf::slider<qpl::size> slider_ensemble;
 	qsf::slider<qpl::size> slider_distinct_colors;
 	qsf::check_box checkbox_switch_states;
 	qpl::size file_index = 0u;
 	bool first_file_index_load = true;
 
 	qpl::circular_array<rule, 512> rules;
+	rule_optimiser optimiser;
 
 	qpl::small_clock update_clock;
 	qpl::f64 update_delta = 0.01;
@@ -769,6 +1918,7 @@ struct main_state : qsf::base_state {
 	qpl::size previous_rule_ctr = 0u;
 	bool auto_update = false;
 	bool hide_hud = false;
+	bool resize_requested = false;
 };
 
 int main() try {